@@ -10,6 +10,21 @@
 // debug output instead
 //#define EEPROM_mgr_FAKE
 
+// Uncomment this to put a read cache between the library and the EEPROM.
+// This is useful when the EEPROM is slow to access (e.g. external EEPROM
+// or EEPROM emulated in flash): functions such as VerifyAll and Begin read
+// the same bytes over and over. The cache is direct-mapped and takes
+// EEPROM_mgr_CACHE_LINES * (EEPROM_mgr_CACHE_LINE_SIZE + 2) bytes of RAM.
+// Writes go straight through to the EEPROM and discard the cache lines
+// they touch, so Verify always compares against what's really stored.
+//#define EEPROM_mgr_CACHE_LINES 4
+
+// Number of bytes per cache line. Each cache miss reads one entire line
+// from the EEPROM with a single block read.
+#ifndef EEPROM_mgr_CACHE_LINE_SIZE
+#define EEPROM_mgr_CACHE_LINE_SIZE 16
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // INCLUDES
@@ -83,6 +98,155 @@ byte eeprom_read_byte(const byte *src)
 #endif
 
 
+//---------------------------------------------------------------------------
+// Read cache
+#ifdef EEPROM_mgr_CACHE_LINES
+static byte         cache_data[EEPROM_mgr_CACHE_LINES]
+                              [EEPROM_mgr_CACHE_LINE_SIZE];
+static word         cache_tag[EEPROM_mgr_CACHE_LINES]; // Line+1; 0=empty
+
+
+//---------------------------------------------------------------------------
+// Find the cache line for an address, loading it from EEPROM on a miss
+//
+// The address must not be beyond the end of the EEPROM.
+static byte *                           // Returns cache line
+cache_line(
+  const byte *addr)                     // EEPROM address
+{
+  word lineno = (size_t)addr / EEPROM_mgr_CACHE_LINE_SIZE;
+  word index = lineno % EEPROM_mgr_CACHE_LINES;
+  byte *result = cache_data[index];
+
+  if (cache_tag[index] != lineno + 1)
+  {
+    size_t base = (size_t)lineno * EEPROM_mgr_CACHE_LINE_SIZE;
+    size_t len = EEPROM_mgr_CACHE_LINE_SIZE;
+
+    // Don't read beyond the end of the EEPROM
+    if (base + len > (size_t)E2END + 1)
+    {
+      len = (size_t)E2END + 1 - base;
+    }
+
+#ifdef EEPROM_mgr_FAKE
+    // The fake read function doesn't return any data
+    memset(result, 0xFF, len);
+#endif
+    eeprom_read_block(result, (const void *)base, len);
+    cache_tag[index] = lineno + 1;
+  }
+
+  return result;
+}
+
+
+//---------------------------------------------------------------------------
+// Discard the cache line for an address, if it's loaded
+//
+// Written data is never copied into the cache: the next read should come
+// from the EEPROM, otherwise Verify wouldn't notice a failed write.
+static void
+cache_discard(
+  const byte *addr)                     // EEPROM address
+{
+  word lineno = (size_t)addr / EEPROM_mgr_CACHE_LINE_SIZE;
+  word index = lineno % EEPROM_mgr_CACHE_LINES;
+
+  if (cache_tag[index] == lineno + 1)
+  {
+    cache_tag[index] = 0;
+  }
+}
+
+
+//---------------------------------------------------------------------------
+// Read a byte through the cache
+static byte
+backend_read_byte(
+  const byte *src)
+{
+  byte result = 0xFF;
+
+  // Addresses beyond the end of the EEPROM (e.g. a signature that doesn't
+  // fit) can't be cached; they read as erased.
+  if ((size_t)src <= (size_t)E2END)
+  {
+    result = cache_line(src)[(size_t)src % EEPROM_mgr_CACHE_LINE_SIZE];
+  }
+
+  return result;
+}
+
+
+//---------------------------------------------------------------------------
+// Read a block through the cache
+static void
+backend_read_block(
+  void *dst,
+  const void *src,
+  size_t len)
+{
+  byte *d = (byte *)dst;
+  const byte *s = (const byte *)src;
+
+  for (; len; len--)
+  {
+    *d++ = backend_read_byte(s++);
+  }
+}
+
+
+//---------------------------------------------------------------------------
+// Write a block to the EEPROM and discard its cache lines
+static void
+backend_write_block(
+  const void *src,
+  void *dst,
+  size_t len)
+{
+  eeprom_write_block(src, dst, len);
+
+  for (byte *d = (byte *)dst; len; len--, d++)
+  {
+    cache_discard(d);
+  }
+}
+
+
+//---------------------------------------------------------------------------
+// Discard all cached data
+void
+eeprom_invalidate_cache()
+{
+  memset(cache_tag, 0, sizeof(cache_tag));
+}
+
+#else
+
+#define backend_read_byte   eeprom_read_byte
+#define backend_read_block  eeprom_read_block
+#define backend_write_block eeprom_write_block
+
+
+//---------------------------------------------------------------------------
+// Discard the cache line for an address (nothing to do without a cache)
+static void
+cache_discard(
+  const byte *)
+{
+}
+
+
+//---------------------------------------------------------------------------
+// Discard all cached data (nothing to do without a cache)
+void
+eeprom_invalidate_cache()
+{
+}
+#endif
+
+
 //---------------------------------------------------------------------------
 // Implementation for the "missing" EEPROM function
 bool                                    // Returns true if all data matches
@@ -97,7 +261,7 @@ eeprom_verify_block(
       
   for (size_t n = 0; n < size; n++, p++, e++)
   {
-    byte b = eeprom_read_byte(e);
+    byte b = backend_read_byte(e);
     if (b != *p)
     {
       result = false;
@@ -109,6 +273,54 @@ eeprom_verify_block(
 }
 
 
+//---------------------------------------------------------------------------
+// Add the size of an item to a signature
+static word                             // Returns updated signature
+next_signature(
+  word signature,                       // Signature so far
+  size_t size)                          // Size of next item
+{
+  signature = ((signature << 1) ^ size) ^ (!(signature & 0x8000));
+
+  // The signature can never be 0 otherwise the code would think it's
+  // not set yet
+  if (!signature)
+  {
+    signature++;
+  }
+
+  return signature;
+}
+
+
+//---------------------------------------------------------------------------
+// Erase the EEPROM from the given address to the end
+static void
+wipe_from(
+  byte *addr)                           // First address to erase
+{
+  bool written = false;
+
+  // Work one cache line at a time: discarding the line after each byte
+  // would make the next byte read the entire line again.
+  for (byte *u = addr; u <= (byte *)E2END; u++)
+  {
+    if (backend_read_byte(u) != 0xFF)
+    {
+      eeprom_write_byte(u, 0xFF);
+      written = true;
+    }
+
+    if ((written) && ((u == (byte *)E2END) || 
+      (((size_t)u + 1) % EEPROM_mgr_CACHE_LINE_SIZE == 0)))
+    {
+      cache_discard(u);
+      written = false;
+    }
+  }
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Base class for EEPROM items
 /////////////////////////////////////////////////////////////////////////////
@@ -188,7 +400,7 @@ EEPROM_mgr::_Store()
 {
   if (m_size)
   {
-    eeprom_write_block(Data(), m_addr, m_size); 
+    backend_write_block(Data(), m_addr, m_size);
   }
 }
 
@@ -200,7 +412,7 @@ EEPROM_mgr::_Retrieve()
 {
   if (m_size)
   {
-    eeprom_read_block(Data(), (const void *)m_addr, m_size);
+    backend_read_block(Data(), (const void *)m_addr, m_size);
   }
 }
 
@@ -261,7 +473,7 @@ EEPROM_mgr::StoreAll(
     // Don't write the signature if it's already there, to reduce wear
     if ((forcewritesig) || (!VerifySignature()))
     {
-      eeprom_write_block(&signature, (void *)nextaddr, sizeof(signature));
+      backend_write_block(&signature, (void *)nextaddr, sizeof(signature));
     }
   }
 }
@@ -330,6 +542,10 @@ EEPROM_mgr::Begin(
 {
   bool result = false;
 
+  // Somebody else may have written to the EEPROM since the last time we
+  // looked at it, so don't trust any cached data.
+  eeprom_invalidate_cache();
+
   // Calculate the signature.
   // Start by resetting it, to make it possible to call this function more
   // than once.
@@ -337,14 +553,7 @@ EEPROM_mgr::Begin(
 
   for (EEPROM_mgr *cur = list; cur; cur = cur->m_next)
   {
-    signature = ((signature << 1) ^ cur->m_size) ^ (!(signature & 0x8000));
-    
-    // The signature can never be 0 otherwise the code would think it's
-    // not set yet
-    if (!signature)
-    {
-      signature++;
-    }
+    signature = next_signature(signature, cur->m_size);
   }
 
   // If (and only if) the list was empty, signature will still be 0 at this
@@ -362,14 +571,7 @@ EEPROM_mgr::Begin(
 
       if (wipeunusedareas)
       {
-        for (byte *u = (byte *)nextaddr + sizeof(signature); 
-          u <= (byte *)E2END; u++)
-        {
-          if (eeprom_read_byte(u) != 0xFF)
-          {
-            eeprom_write_byte(u, 0xFF);
-          }
-        }
+        wipe_from((byte *)nextaddr + sizeof(signature));
       }
     }  
     else if ((retrieveifvalid) && (result))
@@ -382,6 +584,313 @@ EEPROM_mgr::Begin(
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// EEPROM table class
+/////////////////////////////////////////////////////////////////////////////
+
+
+//---------------------------------------------------------------------------
+// Static data for the EEPROM_table class
+const EEPROM_entry *EEPROM_table::table = 0;
+size_t              EEPROM_table::count = 0;
+byte               *EEPROM_table::sigaddr = 0;
+word                EEPROM_table::signature;
+
+
+//---------------------------------------------------------------------------
+// Get an entry from the table in PROGMEM
+void
+EEPROM_table::GetEntry(
+  size_t index,                         // Index in table
+  EEPROM_entry &entry)                  // Output entry
+{
+  memcpy_P(&entry, &table[index], sizeof(entry));
+}
+
+
+//---------------------------------------------------------------------------
+// Find the entry for an item and calculate its EEPROM address
+bool                                    // Returns true if found
+EEPROM_table::Find(
+  const void *data,                     // Pointer to data in RAM
+  EEPROM_entry &entry,                  // Output entry
+  byte *&addr)                          // Output EEPROM address
+{
+  bool result = false;
+
+  // If the table hasn't been set up, nothing can be found
+  if (signature)
+  {
+    addr = 0;
+
+    for (size_t n = 0; n < count; n++)
+    {
+      GetEntry(n, entry);
+
+      if (entry.data == data)
+      {
+        result = true;
+        break;
+      }
+
+      addr += entry.size;
+    }
+  }
+
+  return result;
+}
+
+
+//---------------------------------------------------------------------------
+// Store an item into the EEPROM
+bool                                    // Returns true if item found
+EEPROM_table::Store(
+  const void *data)                     // Pointer to data in RAM
+{
+  EEPROM_entry entry;
+  byte *addr;
+  bool result = Find(data, entry, addr);
+
+  if (result)
+  {
+    backend_write_block(data, addr, entry.size);
+  }
+
+  return result;
+}
+
+
+//---------------------------------------------------------------------------
+// Retrieve an item from the EEPROM
+bool                                    // Returns true if item found
+EEPROM_table::Retrieve(
+  void *data)                           // Pointer to data in RAM
+{
+  EEPROM_entry entry;
+  byte *addr;
+  bool result = Find(data, entry, addr);
+
+  if (result)
+  {
+    backend_read_block(data, (const void *)addr, entry.size);
+  }
+
+  return result;
+}
+
+
+//---------------------------------------------------------------------------
+// Verify if the value of an item matches the value stored in EEPROM
+bool                                    // Returns true if found and match
+EEPROM_table::Verify(
+  const void *data)                     // Pointer to data in RAM
+{
+  EEPROM_entry entry;
+  byte *addr;
+  bool result = Find(data, entry, addr);
+
+  if (result)
+  {
+    result = eeprom_verify_block(data, addr, entry.size);
+  }
+
+  return result;
+}
+
+
+//---------------------------------------------------------------------------
+// Copy the default values from PROGMEM to all items in RAM
+void
+EEPROM_table::RestoreDefaults()
+{
+  EEPROM_entry entry;
+
+  for (size_t n = 0; n < count; n++)
+  {
+    GetEntry(n, entry);
+
+    if (entry.defaultvalue)
+    {
+      memcpy_P(entry.data, entry.defaultvalue, entry.size);
+    }
+  }
+}
+
+
+//---------------------------------------------------------------------------
+// Check if the signature in the EEPROM matches
+bool                                    // Returns true if EEPROM sig valid
+EEPROM_table::VerifySignature(void)
+{
+  // If the table hasn't been set up yet, the result is always false.
+  bool result = false;
+
+  if (signature)
+  {
+    result = eeprom_verify_block(&signature, sigaddr, sizeof(signature));
+  }
+
+  return result;
+}
+
+
+//---------------------------------------------------------------------------
+// Save all values and write the signature
+void
+EEPROM_table::StoreAll(
+  bool forcewritesig /* = false */)
+{
+  if (signature)
+  {
+    EEPROM_entry entry;
+    byte *addr = 0;
+
+    for (size_t n = 0; n < count; n++)
+    {
+      GetEntry(n, entry);
+      backend_write_block(entry.data, addr, entry.size);
+      addr += entry.size;
+    }
+
+    // Don't write the signature if it's already there, to reduce wear
+    if ((forcewritesig) || (!VerifySignature()))
+    {
+      backend_write_block(&signature, sigaddr, sizeof(signature));
+    }
+  }
+}
+
+
+//---------------------------------------------------------------------------
+// Retrieve all values but only if the signature is correct
+bool                                    // Returns true if values retrieved
+EEPROM_table::RetrieveAll()
+{
+  // If the signature doesn't match the EEPROM, don't trash the data
+  bool result = VerifySignature();
+
+  if (result)
+  {
+    EEPROM_entry entry;
+    byte *addr = 0;
+
+    for (size_t n = 0; n < count; n++)
+    {
+      GetEntry(n, entry);
+      backend_read_block(entry.data, (const void *)addr, entry.size);
+      addr += entry.size;
+    }
+  }
+
+  return result;
+}
+
+
+//---------------------------------------------------------------------------
+// Verify that all values in the EEPROM are equal to the stored values
+bool                                    // Returns true if all values match
+EEPROM_table::VerifyAll()
+{
+  // If the signature doesn't match, all bets are off.
+  bool result = VerifySignature();
+
+  if (result)
+  {
+    EEPROM_entry entry;
+    byte *addr = 0;
+
+    for (size_t n = 0; n < count; n++)
+    {
+      GetEntry(n, entry);
+
+      if (!eeprom_verify_block(entry.data, addr, entry.size))
+      {
+        result = false;
+        break;
+      }
+
+      addr += entry.size;
+    }
+  }
+
+  return result;
+}
+
+
+//---------------------------------------------------------------------------
+// This should be called at the beginning of your sketch
+bool
+EEPROM_table::Begin(
+  const EEPROM_entry *entries,          // Table in PROGMEM
+  size_t numentries,                    // Number of entries in table
+  bool storeifinvalid,
+  bool storealways,
+  bool wipeunusedareas,
+  bool retrieveifvalid)
+{
+  bool result = false;
+  EEPROM_entry entry;
+
+  // Somebody else may have written to the EEPROM since the last time we
+  // looked at it, so don't trust any cached data.
+  eeprom_invalidate_cache();
+
+  // The variables only need their defaults the first time a table is set
+  // up. After that, they hold the sketch's current values.
+  bool firsttime = (table != entries);
+
+  table = entries;
+  count = numentries;
+
+  // Calculate the signature and the location where it's stored.
+  // Start by resetting it, to make it possible to call this function more
+  // than once.
+  signature = 0;
+  sigaddr = 0;
+
+  for (size_t n = 0; n < count; n++)
+  {
+    GetEntry(n, entry);
+
+    signature = next_signature(signature, entry.size);
+    sigaddr += entry.size;
+  }
+
+  // If the table was empty, signature will still be 0 at this time, and we
+  // should simply return 0 to indicate there was no signature in the
+  // EEPROM. Otherwise, store or retrieve the items in the table.
+  if (signature)
+  {
+    // The variables don't get their default values from a constructor, so
+    // copy them now. If the EEPROM is retrieved, they're overwritten.
+    if (firsttime)
+    {
+      RestoreDefaults();
+    }
+
+    result = VerifySignature();
+
+    if ((storealways) || ((!result) && (storeifinvalid)))
+    {
+      // Write default values including the signature
+      // Don't bother verifying the signature, just write it
+      StoreAll(true);
+
+      if (wipeunusedareas)
+      {
+        wipe_from(sigaddr + sizeof(signature));
+      }
+    }
+    else if ((retrieveifvalid) && (result))
+    {
+      RetrieveAll();
+    }
+  }
+
+  return result;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // END
 /////////////////////////////////////////////////////////////////////////////
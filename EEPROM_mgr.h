@@ -41,6 +41,14 @@
   needs this, it can call the Verify or VerifyAll function to make sure
   that the EEPROM contains the same data as the items, after they are
   supposed to be written.
+
+  On small AVRs with many settings, the RAM used by the EEPROM_item objects
+  can add up. As an alternative, you can describe your settings with a
+  table of EEPROM_entry structures in PROGMEM and use the static functions
+  of the EEPROM_table class. RAM then only holds the data itself, and
+  default values are copied from flash when the EEPROM is initialized.
+  Don't use EEPROM_item variables and an EEPROM_table in the same sketch:
+  both start storing data at EEPROM address 0.
 */
 
 
@@ -59,6 +67,14 @@ eeprom_verify_block(
   size_t size);                         // Number of bytes to compare
 
 
+//--------------------------------------------------------------------------
+// Discard the contents of the read cache (see EEPROM_mgr_CACHE_LINES).
+// Call this if your sketch writes to the EEPROM without using this library.
+// This does nothing if the cache is disabled.
+void
+eeprom_invalidate_cache();
+
+
 ////////////////////////////////////////////////////////////////////////////
 // Base class for EEPROM items
 ////////////////////////////////////////////////////////////////////////////
@@ -292,6 +308,157 @@ public:
 };
 
 
+////////////////////////////////////////////////////////////////////////////
+// EEPROM table entry
+////////////////////////////////////////////////////////////////////////////
+//
+// Describes one item in a table that's stored in PROGMEM. The EEPROM
+// address of each item is not stored: items are stored in the order in
+// which they appear in the table.
+//
+// Use the EEPROM_ENTRY macro to declare entries, for example:
+//
+//   int volume;
+//   const int volume_default PROGMEM = 5;
+//   char name[10];
+//
+//   const EEPROM_entry settings[] PROGMEM =
+//   {
+//     EEPROM_ENTRY(volume, &volume_default),
+//     EEPROM_ENTRY(name, 0),             // No default: name is stored as-is
+//   };
+//
+//   void setup()
+//   {
+//     EEPROM_table::Begin(settings, EEPROM_TABLE_SIZE(settings));
+//   }
+struct EEPROM_entry
+{
+  void             *data;               // Pointer to data in RAM
+  const void       *defaultvalue;       // Default in PROGMEM; 0=none
+  size_t            size;               // Size of data
+};
+
+#define EEPROM_ENTRY(var, defaultptr) { &(var), (defaultptr), sizeof(var) }
+#define EEPROM_TABLE_SIZE(table) (sizeof(table) / sizeof((table)[0]))
+
+
+////////////////////////////////////////////////////////////////////////////
+// EEPROM table class
+////////////////////////////////////////////////////////////////////////////
+//
+// Alternative for EEPROM_item that keeps the item descriptions in PROGMEM.
+// All functions are static; there's only one table per sketch. Individual
+// items are identified by a pointer to their data in RAM.
+class EEPROM_table
+{
+  //------------------------------------------------------------------------
+  // Static variables
+protected:
+  static const EEPROM_entry *table;     // Table in PROGMEM
+  static size_t      count;             // Number of entries in table
+  static byte       *sigaddr;           // Address of signature in EEPROM
+  static word        signature;         // non-zero=table is set up
+
+  
+  //------------------------------------------------------------------------
+  // Get an entry from the table in PROGMEM
+protected:
+  static void GetEntry(
+    size_t index,                       // Index in table
+    EEPROM_entry &entry);               // Output entry
+
+  
+  //------------------------------------------------------------------------
+  // Find the entry for an item and calculate its EEPROM address
+protected:
+  static bool                           // Returns true if found
+  Find(
+    const void *data,                   // Pointer to data in RAM
+    EEPROM_entry &entry,                // Output entry
+    byte *&addr);                       // Output EEPROM address
+
+  
+  //------------------------------------------------------------------------
+  // Store an item into the EEPROM
+public:
+  static bool                           // Returns true if item found
+  Store(
+    const void *data);                  // Pointer to data in RAM
+
+
+  //------------------------------------------------------------------------
+  // Retrieve an item from the EEPROM
+public:
+  static bool                           // Returns true if item found
+  Retrieve(
+    void *data);                        // Pointer to data in RAM
+
+
+  //------------------------------------------------------------------------
+  // Verify if the value of an item matches the value stored in EEPROM
+public:
+  static bool                           // Returns true if found and match
+  Verify(
+    const void *data);                  // Pointer to data in RAM
+
+
+  //------------------------------------------------------------------------
+  // Copy the default values from PROGMEM to all items in RAM
+  //
+  // Items that have no default value are left alone.
+public:
+  static void RestoreDefaults();
+
+
+  //------------------------------------------------------------------------
+  // Check if the signature in the EEPROM matches
+public:
+  static bool                           // Returns true if EEPROM sig valid
+  VerifySignature(void);
+
+
+  //------------------------------------------------------------------------
+  // Save all values and write the signature
+public:
+  static void StoreAll(
+    bool forcewritesig = false);
+
+
+  //------------------------------------------------------------------------
+  // Retrieve all values but only if the signature is correct
+public:
+  static bool                           // Returns true if values retrieved
+  RetrieveAll();
+
+
+  //------------------------------------------------------------------------
+  // Verify that all values in the EEPROM are equal to the stored values
+public:
+  static bool                           // Returns true if all values match
+  VerifyAll();
+
+
+  //------------------------------------------------------------------------
+  // This should be called at the beginning of your sketch
+  //
+  // Works the same as EEPROM_mgr::Begin. Because table variables have no
+  // constructors, the first call for a table copies the default values
+  // from PROGMEM into RAM, whatever the parameters are. Retrieving from
+  // the EEPROM then overwrites them. Later calls for the same table keep
+  // the current values, the same way EEPROM_item does.
+public:
+  static bool
+  Begin(
+    const EEPROM_entry *entries,        // Table in PROGMEM
+    size_t numentries,                  // Number of entries in table
+    bool storeifinvalid = true,
+    bool storealways = false,
+    bool wipeunusedareas = true,
+    bool retrieveifvalid = true);
+};
+
+
 ////////////////////////////////////////////////////////////////////////////
 // END
 ////////////////////////////////////////////////////////////////////////////
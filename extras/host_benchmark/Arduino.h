@@ -0,0 +1,25 @@
+/*
+  EEPROM Manager Library - host benchmark
+  ---------------------------------------
+  Minimal stand-in for the Arduino core so the library can be compiled on
+  a PC. Only what the library uses is declared here.
+*/
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t  byte;
+typedef uint16_t word;
+
+// Size of the simulated EEPROM (same as ATmega328P)
+#define E2END    0x3FF
+
+// On a PC, "program memory" is just regular memory
+#define PROGMEM
+#define memcpy_P memcpy
+
+#endif
@@ -0,0 +1,25 @@
+/*
+  EEPROM Manager Library - host benchmark
+  ---------------------------------------
+  Simulated EEPROM that counts the number of transactions, i.e. the
+  number of calls that would go to a slow backend such as an external
+  EEPROM chip.
+*/
+
+#ifndef AVR_EEPROM_H
+#define AVR_EEPROM_H
+
+#include <Arduino.h>
+
+extern byte           sim_eeprom[E2END + 1];
+extern unsigned long  sim_reads;        // Number of read transactions
+extern unsigned long  sim_readbytes;    // Number of bytes read
+extern unsigned long  sim_writes;       // Number of write transactions
+extern bool           sim_dropwrites;   // true=simulate failing writes
+
+byte eeprom_read_byte(const byte *src);
+void eeprom_read_block(void *dst, const void *src, size_t len);
+void eeprom_write_byte(byte *dst, byte b);
+void eeprom_write_block(const void *src, void *dst, size_t len);
+
+#endif
@@ -0,0 +1,265 @@
+/*
+  EEPROM Manager Library - host benchmark
+  ---------------------------------------
+  Counts the EEPROM transactions that Begin and VerifyAll generate, to
+  show the effect of the read cache, for EEPROM_item as well as for
+  EEPROM_table. It also checks that EEPROM_table works as intended; the
+  exit code is nonzero if any check fails. Build and run it on a PC from the
+  root of the library, once without and once with the cache:
+
+    g++ -I extras/host_benchmark extras/host_benchmark/host_benchmark.cpp \
+      EEPROM_mgr.cpp -o host_benchmark && ./host_benchmark
+
+    g++ -DEEPROM_mgr_CACHE_LINES=4 -I extras/host_benchmark \
+      extras/host_benchmark/host_benchmark.cpp \
+      EEPROM_mgr.cpp -o host_benchmark && ./host_benchmark
+*/
+
+#include <stdio.h>
+
+#include <Arduino.h>
+#include <avr/eeprom.h>
+
+#include "../../EEPROM_mgr.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Simulated EEPROM
+/////////////////////////////////////////////////////////////////////////////
+
+
+byte                sim_eeprom[E2END + 1];
+unsigned long       sim_reads;
+unsigned long       sim_readbytes;
+unsigned long       sim_writes;
+bool                sim_dropwrites;
+
+
+byte eeprom_read_byte(const byte *src)
+{
+  sim_reads++;
+  sim_readbytes++;
+  return sim_eeprom[(size_t)src];
+}
+
+
+void eeprom_read_block(void *dst, const void *src, size_t len)
+{
+  sim_reads++;
+  sim_readbytes += len;
+  memcpy(dst, &sim_eeprom[(size_t)src], len);
+}
+
+
+void eeprom_write_byte(byte *dst, byte b)
+{
+  sim_writes++;
+  if (!sim_dropwrites)
+  {
+    sim_eeprom[(size_t)dst] = b;
+  }
+}
+
+
+void eeprom_write_block(const void *src, void *dst, size_t len)
+{
+  sim_writes++;
+  if (!sim_dropwrites)
+  {
+    memcpy(&sim_eeprom[(size_t)dst], src, len);
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Items
+/////////////////////////////////////////////////////////////////////////////
+
+
+EEPROM_item<long>   item_long(5);
+EEPROM_item<int>    item_int(7);
+EEPROM_item<char[20]> item_string;
+
+
+int                 table_int;
+const int           table_int_default PROGMEM = 7;
+long                table_long;
+const long          table_long_default PROGMEM = 5;
+char                table_string[20];
+
+const EEPROM_entry  table[] PROGMEM =
+{
+  EEPROM_ENTRY(table_int, &table_int_default),
+  EEPROM_ENTRY(table_long, &table_long_default),
+  EEPROM_ENTRY(table_string, 0),
+};
+
+// EEPROM address of the signature: items are stored back to back
+const size_t        table_sigaddr = 
+  sizeof(table_int) + sizeof(table_long) + sizeof(table_string);
+
+int                 not_in_table;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Benchmark
+/////////////////////////////////////////////////////////////////////////////
+
+
+//---------------------------------------------------------------------------
+// Print and reset the transaction counters
+static void
+report(
+  const char *what,
+  bool result)
+{
+  printf("%-32s result=%d reads=%lu (%lu bytes) writes=%lu\n", what, 
+    result, sim_reads, sim_readbytes, sim_writes);
+
+  sim_reads = 0;
+  sim_readbytes = 0;
+  sim_writes = 0;
+}
+
+
+//---------------------------------------------------------------------------
+// Print the result of a check and remember failures
+static bool         failed;
+
+static void
+check(
+  const char *what,
+  bool ok)
+{
+  printf("%-32s %s\n", what, ok ? "ok" : "FAILED");
+
+  if (!ok)
+  {
+    failed = true;
+  }
+
+  // Checks aren't part of the benchmark
+  sim_reads = 0;
+  sim_readbytes = 0;
+  sim_writes = 0;
+}
+
+
+//---------------------------------------------------------------------------
+// Benchmark for EEPROM_item
+static void
+benchmark_items()
+{
+  printf("EEPROM_item:\n");
+
+  // Start with an EEPROM that holds garbage, so Begin has to initialize
+  // and wipe it.
+  memset(sim_eeprom, 0x55, sizeof(sim_eeprom));
+
+  report("Begin (first boot)", EEPROM_mgr::Begin());
+  report("VerifyAll", EEPROM_mgr::VerifyAll());
+  report("Begin (valid signature)", EEPROM_mgr::Begin());
+  report("VerifyAll", EEPROM_mgr::VerifyAll());
+
+  // Re-initialize; the unused area is already erased this time
+  report("Begin (store always)", EEPROM_mgr::Begin(true, true));
+  report("VerifyAll", EEPROM_mgr::VerifyAll());
+
+  item_int.m_data = 9;
+  item_int.Store();
+  report("Store", true);
+  report("VerifyAll", EEPROM_mgr::VerifyAll());
+
+  // A failed write must be detected, with or without the cache
+  sim_dropwrites = true;
+  item_int.m_data = 11;
+  item_int.Store();
+  report("Store (write fails)", true);
+  report("Verify (expect result=0)", item_int.Verify());
+  sim_dropwrites = false;
+}
+
+
+//---------------------------------------------------------------------------
+// Benchmark for EEPROM_table
+static void
+benchmark_table()
+{
+  size_t count = EEPROM_TABLE_SIZE(table);
+
+  printf("EEPROM_table:\n");
+
+  // First boot: the defaults come from PROGMEM
+  memset(sim_eeprom, 0x55, sizeof(sim_eeprom));
+  eeprom_invalidate_cache();
+
+  report("Begin (first boot)", EEPROM_table::Begin(table, count));
+  report("VerifyAll", EEPROM_table::VerifyAll());
+  check("Defaults from table", 
+    (table_int == 7) && (table_long == 5) && (!table_string[0]));
+  check("Signature after items", 
+    (EEPROM_table::VerifySignature()) && 
+    (sim_eeprom[table_sigaddr + sizeof(word)] == 0xFF));
+
+  sim_eeprom[table_sigaddr] ^= 0xFF;
+  eeprom_invalidate_cache();
+  check("Signature at sum of sizes", !EEPROM_table::VerifySignature());
+  sim_eeprom[table_sigaddr] ^= 0xFF;
+  eeprom_invalidate_cache();
+
+  // Valid signature: the values are retrieved from the EEPROM
+  sim_eeprom[0] = 42;
+  sim_eeprom[1] = 0;
+  sim_eeprom[2] = 0;
+  sim_eeprom[3] = 0;
+  table_int = 0;
+  report("Begin (valid signature)", EEPROM_table::Begin(table, count));
+  check("Values retrieved", (table_int == 42) && (table_long == 5));
+  report("VerifyAll", EEPROM_table::VerifyAll());
+
+  // Calling Begin again keeps the current values
+  table_long = 77;
+  EEPROM_table::Begin(table, count, true, false, true, false);
+  check("Begin keeps current values", table_long == 77);
+
+  long stored;
+  EEPROM_table::Begin(table, count, true, true);
+  memcpy(&stored, &sim_eeprom[sizeof(table_int)], sizeof(stored));
+  check("Begin stores current values", stored == 77);
+
+  // Single items are identified by their data pointer
+  check("Store", EEPROM_table::Store(&table_long));
+  check("Verify", EEPROM_table::Verify(&table_long));
+  table_long = 0;
+  check("Verify (changed)", !EEPROM_table::Verify(&table_long));
+  check("Retrieve", 
+    (EEPROM_table::Retrieve(&table_long)) && (table_long == 77));
+  check("Store (not in table)", !EEPROM_table::Store(&not_in_table));
+  check("Verify (not in table)", !EEPROM_table::Verify(&not_in_table));
+  check("Retrieve (not in table)", 
+    !EEPROM_table::Retrieve(&not_in_table));
+  report("VerifyAll", EEPROM_table::VerifyAll());
+
+  // A failed write must be detected, with or without the cache
+  sim_dropwrites = true;
+  table_int = 11;
+  EEPROM_table::Store(&table_int);
+  report("Store (write fails)", true);
+  report("Verify (expect result=0)", EEPROM_table::Verify(&table_int));
+  sim_dropwrites = false;
+}
+
+
+int main()
+{
+#ifdef EEPROM_mgr_CACHE_LINES
+  printf("Cache: %d lines\n", EEPROM_mgr_CACHE_LINES);
+#else
+  printf("Cache: disabled\n");
+#endif
+
+  benchmark_items();
+  benchmark_table();
+
+  return failed ? 1 : 0;
+}